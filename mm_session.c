@@ -19,12 +19,23 @@
  *
  */
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE	/* dup3 */
+#endif
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
 #include <unistd.h>
+#include <pthread.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <sys/inotify.h>
+#include <dirent.h>
+#include <signal.h>
+#include <time.h>
 #include <mm_session_private.h>
 #include <mm_error.h>
 #include <errno.h>
@@ -35,6 +46,17 @@
 
 #define EXPORT_API __attribute__((__visibility__("default")))
 #define MAX_FILE_LENGTH 256
+#define SESSION_DIR "/tmp"
+#define SESSION_DIR_ENV "MM_SESSION_DIR"
+#define PRECONNECT_ENV "MM_SESSION_PRECONNECT"
+#define IPC_TIMEOUT_ENV "MM_SESSION_IPC_TIMEOUT_MS"
+#define FORK_INHERIT_ENV "MM_SESSION_FORK_INHERIT"
+#define SESSION_FILE_PREFIX "mm_session_"
+#define WATCH_BUFFER_LENGTH 4096
+#define WATCH_EVENTS (IN_CREATE | IN_CLOSE_WRITE | IN_MOVED_TO | IN_DELETE)
+#define WATCH_REARM_INTERVAL 1	/* seconds */
+#define LOOKUP_CACHE_SIZE 8
+#define SNAPSHOT_INITIAL_SIZE 16
 #define LOG_TAG	"MMFW_SESSION"
 #define debug_log(fmt, arg...) SLOG(LOG_VERBOSE, LOG_TAG, "[%s:%d] "fmt"\n", __FUNCTION__,__LINE__,##arg)
 #define debug_warning(fmt, arg...) SLOG(LOG_WARN, LOG_TAG, "[%s:%d] "fmt"\n", __FUNCTION__,__LINE__,##arg)
@@ -47,12 +69,983 @@ typedef struct {
 	session_event_t event;
 }session_monitor_t;
 
+typedef struct {
+	int valid;
+	ASM_sound_events_t event;
+	ASM_sound_states_t state;
+	ASM_resource_t resource;
+	int call_handle;	/* registered to g_call_asm_handle at init, otherwise monitor is used */
+	const char *name;
+}session_type_desc_t;
+
+typedef enum {
+	PRECONNECT_NONE = 0,
+	PRECONNECT_RUNNING,
+	PRECONNECT_DONE,
+}session_preconnect_state_t;
+
+typedef enum {
+	IPC_GET_PROCESS_SESSION_STATE = 0,
+	IPC_GET_SUBSESSION,
+}session_ipc_op_t;
+
+typedef struct session_ipc {
+	session_ipc_op_t op;
+	int handle;
+	int ret;
+	int error;
+	ASM_sound_states_t state;
+	mm_subsession_t subsession;
+	int done;
+	int refcount;	/* caller and worker, last one frees */
+	int unregister;	/* handle is unregistered by worker after reply */
+	ASM_sound_events_t unregister_event;
+	struct session_ipc *next;	/* g_ipc_pending link */
+}session_ipc_t;
+
+/* session record file layout, readers of type only read first int */
+typedef struct {
+	int sessiontype;
+	int subsession;	/* -1 until mm_session_set_subsession */
+	long long started;	/* time session type was written, kept by subsession updates */
+}session_record_t;
+
+typedef struct {
+	int dirfd;
+	int count;
+	int size;
+	int error;
+	mm_session_record_t *records;
+}session_snapshot_t;
+
+typedef struct {
+	pid_t pid;
+	ino_t ino;
+	off_t size;
+	struct timespec mtime;
+	int sessiontype;
+	unsigned int last_used;
+}session_lookup_t;
+
+typedef struct {
+	int id;
+	int pid;
+	session_watch_cb fn;
+	void* data;
+	int removed;
+}session_watch_t;
+
+static const session_type_desc_t g_session_types[MM_SESSION_PRIVATE_TYPE_NUM] = {
+	[MM_SESSION_TYPE_SHARE]		= { 1, ASM_EVENT_MONITOR,	ASM_STATE_NONE,		ASM_RESOURCE_NONE, 0, "SHARE" },
+	[MM_SESSION_TYPE_EXCLUSIVE]	= { 1, ASM_EVENT_MONITOR,	ASM_STATE_NONE,		ASM_RESOURCE_NONE, 0, "EXCLUSIVE" },
+	[MM_SESSION_TYPE_NOTIFY]	= { 1, ASM_EVENT_MONITOR,	ASM_STATE_NONE,		ASM_RESOURCE_NONE, 0, "NOTIFY" },
+	[MM_SESSION_TYPE_CALL]		= { 1, ASM_EVENT_CALL,		ASM_STATE_PLAYING,	ASM_RESOURCE_NONE, 1, "CALL" },
+	[MM_SESSION_TYPE_ALARM]		= { 1, ASM_EVENT_MONITOR,	ASM_STATE_NONE,		ASM_RESOURCE_NONE, 0, "ALARM" },
+	[MM_SESSION_TYPE_VIDEOCALL]	= { 1, ASM_EVENT_VIDEOCALL,	ASM_STATE_PLAYING,	ASM_RESOURCE_CAMERA | ASM_RESOURCE_VIDEO_OVERLAY, 1, "VIDEOCALL" },
+	[MM_SESSION_TYPE_RICH_CALL]	= { 1, ASM_EVENT_RICH_CALL,	ASM_STATE_PLAYING,	ASM_RESOURCE_NONE, 1, "RICH-CALL" },
+};
+
+static int g_session_type = -1;
+static int g_fork_inherit = 0;
+static int g_fork_publish = 0;	/* inherited type is not written yet, set in child only */
+static pthread_mutex_t g_fork_lock = PTHREAD_MUTEX_INITIALIZER;
+
 int g_call_asm_handle = -1;
 int g_monitor_asm_handle = -1;
 session_monitor_t g_monitor_data;
+static pthread_mutex_t g_monitor_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_monitor_cond = PTHREAD_COND_INITIALIZER;
+static int g_monitor_dispatching = 0;
+static pthread_t g_monitor_dispatch_thread;
+
+static char g_state_dir[MAX_FILE_LENGTH] = {0,};
+static int g_state_dir_fd = -1;
+static pthread_mutex_t g_state_dir_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static session_preconnect_state_t g_preconnect_state = PRECONNECT_NONE;
+static int g_preconnect_asm_handle = -1;
+static pthread_mutex_t g_preconnect_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_preconnect_cond = PTHREAD_COND_INITIALIZER;
+
+static unsigned int g_ipc_timeout = 0;
+static pthread_mutex_t g_ipc_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_ipc_cond;
+static pthread_once_t g_ipc_once = PTHREAD_ONCE_INIT;
+static session_ipc_t *g_ipc_pending = NULL;	/* timed out requests, their handles are busy */
+static int g_last_state_valid = 0;
+static ASM_sound_states_t g_last_state = ASM_STATE_NONE;
+static int g_last_subsession_valid = 0;
+static mm_subsession_t g_last_subsession = MM_SUBSESSION_TYPE_VOICE;
+
+static session_lookup_t g_lookup_cache[LOOKUP_CACHE_SIZE];
+static unsigned int g_lookup_tick = 0;
+static mm_session_stats_t g_stats;
+static pthread_mutex_t g_lookup_lock = PTHREAD_MUTEX_INITIALIZER;
+static time_t g_boot_time = 0;
+static pthread_once_t g_boot_once = PTHREAD_ONCE_INIT;
+
+static GList *g_watch_list = NULL;
+static GHashTable *g_watch_known = NULL;	/* pid -> session type, -1 until created record is written */
+static GIOChannel *g_watch_channel = NULL;
+static guint g_watch_source = 0;
+static int g_watch_fd = -1;
+static int g_watch_wd = -1;
+static char g_watch_dir[MAX_FILE_LENGTH] = {0,};
+static GHashTable *g_watch_lost = NULL;	/* records known when inotify failed, compared after re-arm */
+static int g_watch_last_id = 0;
+static int g_watch_dispatching = 0;
 
 ASM_cb_result_t asm_monitor_callback(int handle, ASM_event_sources_t event_src, ASM_sound_commands_t command, unsigned int sound_status, void* cb_data);
 
+static const session_type_desc_t* _session_type_desc(int sessiontype)
+{
+	if(sessiontype < 0 || sessiontype >= MM_SESSION_PRIVATE_TYPE_NUM || !g_session_types[sessiontype].valid)
+		return NULL;
+
+	return &g_session_types[sessiontype];
+}
+
+/* caller should hold g_state_dir_lock, returns -1 if directory can not be decided */
+static int _session_state_dir_resolve(void)
+{
+	const char *env = NULL;
+
+	if(g_state_dir[0] != '\0')
+		return 0;
+
+	env = getenv(SESSION_DIR_ENV);
+	if(env == NULL || env[0] == '\0') {
+		env = SESSION_DIR;
+	} else if(strlen(env) >= sizeof(g_state_dir)) {
+		/* falling back to shared default would mix records of separated namespaces */
+		debug_error("%s is too long, session records are not accessible", SESSION_DIR_ENV);
+		return -1;
+	}
+	snprintf(g_state_dir, sizeof(g_state_dir), "%s", env);
+
+	return 0;
+}
+
+static int _session_state_dirfd(void)
+{
+	int fd = -1;
+
+	pthread_mutex_lock(&g_state_dir_lock);
+	if(g_state_dir_fd == -1 && 0 == _session_state_dir_resolve()) {
+		g_state_dir_fd = open(g_state_dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+		if(g_state_dir_fd < 0)
+			debug_error("open(%s) failed with %d", g_state_dir, errno);
+	}
+	fd = g_state_dir_fd;
+	pthread_mutex_unlock(&g_state_dir_lock);
+
+	return fd;
+}
+
+static void _session_record_name(char *name, size_t size, pid_t pid)
+{
+	snprintf(name, size, SESSION_FILE_PREFIX"%d", pid);
+}
+
+/* returns pid of session record file name, or -1 */
+static int _session_record_pid(const char *name)
+{
+	char *end = NULL;
+	long pid;
+
+	if(strncmp(name, SESSION_FILE_PREFIX, sizeof(SESSION_FILE_PREFIX)-1))
+		return -1;
+
+	pid = strtol(name + sizeof(SESSION_FILE_PREFIX)-1, &end, 10);
+	if(end == NULL || *end != '\0' || pid <= 0)
+		return -1;
+
+	return (int)pid;
+}
+
+static int _session_pid_alive(pid_t pid)
+{
+	return (0 == kill(pid, 0) || errno == EPERM);
+}
+
+/* calls fn for each session record in state directory until fn returns non-zero */
+static int _session_scan_records(int (*fn)(pid_t pid, void *data), void *data)
+{
+	struct dirent *entry = NULL;
+	DIR *dir = NULL;
+	int dirfd = -1;
+	int fd = -1;
+	int pid;
+
+	dirfd = _session_state_dirfd();
+	if(dirfd < 0)
+		return MM_ERROR_FILE_NOT_FOUND;
+
+	/* own descriptor, so cached one keeps no directory stream position */
+	fd = openat(dirfd, ".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if(fd < 0)
+		return MM_ERROR_FILE_NOT_FOUND;
+	dir = fdopendir(fd);
+	if(dir == NULL) {
+		close(fd);
+		return MM_ERROR_FILE_NOT_FOUND;
+	}
+
+	while((entry = readdir(dir)) != NULL) {
+		pid = _session_record_pid(entry->d_name);
+		if(pid < 0)
+			continue;
+		if(fn(pid, data))
+			break;
+	}
+	closedir(dir);
+
+	return MM_ERROR_NONE;
+}
+
+/* child of multi-threaded process should not do file I/O in atfork handler,
+ * so inherited type is written by first library call of child */
+static void _session_fork_publish_pending(int publish)
+{
+	session_record_t record = { -1, -1, 0 };
+	char filename[MAX_FILE_LENGTH];
+	char tmpname[MAX_FILE_LENGTH];
+	int dirfd = -1;
+	int fd = -1;
+
+	pthread_mutex_lock(&g_fork_lock);
+	if(!g_fork_publish || !publish) {
+		/* caller writes or removes own record itself */
+		g_fork_publish = 0;
+		pthread_mutex_unlock(&g_fork_lock);
+		return;
+	}
+	g_fork_publish = 0;
+
+	dirfd = _session_state_dirfd();
+	if(dirfd < 0)
+		goto EXIT;
+
+	record.sessiontype = g_session_type;
+	record.started = (long long)time(NULL);
+	_session_record_name(filename, sizeof(filename), getpid());
+	if(sizeof(tmpname) <= (size_t)snprintf(tmpname, sizeof(tmpname), ".%s.tmp", filename))
+		goto EXIT;
+
+	/* record appears complete to readers and watchers */
+	fd = openat(dirfd, tmpname, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if(fd < 0)
+		goto EXIT;
+	if(sizeof(record) != write(fd, &record, sizeof(record)) || 0 > fchmod(fd, 00777)) {
+		close(fd);
+		unlinkat(dirfd, tmpname, 0);
+		goto EXIT;
+	}
+	close(fd);
+
+	if(0 > renameat(dirfd, tmpname, dirfd, filename))
+		unlinkat(dirfd, tmpname, 0);
+
+EXIT:
+	pthread_mutex_unlock(&g_fork_lock);
+}
+
+static void _session_boot_time_init(void)
+{
+	char line[128];
+	FILE *fp = NULL;
+
+	fp = fopen("/proc/stat", "re");
+	if(fp == NULL)
+		return;
+	while(fgets(line, sizeof(line), fp)) {
+		if(0 == strncmp(line, "btime ", 6)) {
+			g_boot_time = (time_t)strtoll(line + 6, NULL, 10);
+			break;
+		}
+	}
+	fclose(fp);
+}
+
+/* returns start time of process in seconds since epoch, or 0 if unknown */
+static time_t _session_proc_started(pid_t pid)
+{
+	char path[MAX_FILE_LENGTH];
+	char buf[512];
+	unsigned long long starttime = 0;
+	char *ptr = NULL;
+	ssize_t length;
+	long ticks;
+	int field;
+	int fd;
+
+	pthread_once(&g_boot_once, _session_boot_time_init);
+	ticks = sysconf(_SC_CLK_TCK);
+	if(g_boot_time == 0 || ticks <= 0)
+		return 0;
+
+	snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+	fd = open(path, O_RDONLY | O_CLOEXEC);
+	if(fd < 0)
+		return 0;
+	length = read(fd, buf, sizeof(buf)-1);
+	close(fd);
+	if(length <= 0)
+		return 0;
+	buf[length] = '\0';
+
+	/* comm may contain spaces, so count fields after last ')'. starttime is 22nd field in ticks since boot */
+	ptr = strrchr(buf, ')');
+	for(field = 2; ptr && field < 22; field++)
+		ptr = strchr(ptr + 1, ' ');
+	if(ptr == NULL)
+		return 0;
+	starttime = strtoull(ptr + 1, NULL, 10);
+
+	return g_boot_time + (time_t)(starttime / ticks);
+}
+
+/* caller should hold g_lookup_lock */
+static session_lookup_t* _session_lookup_find(pid_t pid)
+{
+	int i;
+
+	for(i = 0; i < LOOKUP_CACHE_SIZE; i++) {
+		if(g_lookup_cache[i].pid == pid)
+			return &g_lookup_cache[i];
+	}
+	return NULL;
+}
+
+static void _session_lookup_invalidate(pid_t pid)
+{
+	session_lookup_t *entry = NULL;
+
+	pthread_mutex_lock(&g_lookup_lock);
+	entry = _session_lookup_find(pid);
+	if(entry)
+		entry->pid = 0;
+	pthread_mutex_unlock(&g_lookup_lock);
+}
+
+static int _session_lookup_read(int dirfd, pid_t pid, int *sessiontype)
+{
+	char filename[MAX_FILE_LENGTH];
+	session_lookup_t *entry = NULL;
+	session_record_t record = { -1, -1, 0 };
+	time_t started;
+	time_t proc_started;
+	struct stat st;
+	ssize_t length;
+	int fd = -1;
+	int i;
+
+	_session_record_name(filename, sizeof(filename), pid);
+
+	/* one fstatat proves the cached type is still current */
+	if(0 > fstatat(dirfd, filename, &st, 0)) {
+		_session_lookup_invalidate(pid);
+		return MM_ERROR_INVALID_HANDLE;
+	}
+
+	pthread_mutex_lock(&g_lookup_lock);
+	entry = _session_lookup_find(pid);
+	if(entry && entry->ino == st.st_ino && entry->size == st.st_size &&
+			entry->mtime.tv_sec == st.st_mtim.tv_sec && entry->mtime.tv_nsec == st.st_mtim.tv_nsec) {
+		entry->last_used = ++g_lookup_tick;
+		*sessiontype = entry->sessiontype;
+		g_stats.lookup_hits++;
+		pthread_mutex_unlock(&g_lookup_lock);
+		return MM_ERROR_NONE;
+	}
+	pthread_mutex_unlock(&g_lookup_lock);
+
+	fd = openat(dirfd, filename, O_RDONLY | O_CLOEXEC);
+	if(fd < 0) {
+		_session_lookup_invalidate(pid);
+		return MM_ERROR_INVALID_HANDLE;
+	}
+	length = read(fd, &record, sizeof(record));
+	if(0 > fstat(fd, &st) || length < (ssize_t)sizeof(int)) {
+		close(fd);
+		return MM_ERROR_INVALID_HANDLE;
+	}
+	close(fd);
+
+	/* owner killed before removing record leaves it to next process of same pid.
+	 * record written before current process started is stale, 1 second is rounding of both times */
+	started = (length >= (ssize_t)sizeof(record)) ? (time_t)record.started : st.st_mtime;
+	proc_started = _session_proc_started(pid);
+	if(proc_started != 0 && started + 1 < proc_started) {
+		pthread_mutex_lock(&g_lookup_lock);
+		g_stats.lookup_misses++;
+		g_stats.lookup_recycled++;
+		entry = _session_lookup_find(pid);
+		if(entry)
+			entry->pid = 0;
+		pthread_mutex_unlock(&g_lookup_lock);
+		return MM_ERROR_INVALID_HANDLE;
+	}
+
+	pthread_mutex_lock(&g_lookup_lock);
+	g_stats.lookup_misses++;
+	entry = _session_lookup_find(pid);
+	if(entry == NULL) {
+		entry = &g_lookup_cache[0];
+		for(i = 1; i < LOOKUP_CACHE_SIZE; i++) {
+			if(g_lookup_cache[i].last_used < entry->last_used)
+				entry = &g_lookup_cache[i];
+		}
+	}
+	entry->pid = pid;
+	entry->ino = st.st_ino;
+	entry->size = st.st_size;
+	entry->mtime = st.st_mtim;
+	entry->sessiontype = record.sessiontype;
+	entry->last_used = ++g_lookup_tick;
+	pthread_mutex_unlock(&g_lookup_lock);
+
+	*sessiontype = record.sessiontype;
+
+	return MM_ERROR_NONE;
+}
+
+EXPORT_API
+int mm_session_get_stats(mm_session_stats_t *stats)
+{
+	if(stats == NULL)
+		return MM_ERROR_INVALID_ARGUMENT;
+
+	pthread_mutex_lock(&g_lookup_lock);
+	*stats = g_stats;
+	pthread_mutex_unlock(&g_lookup_lock);
+
+	return MM_ERROR_NONE;
+}
+
+static void _session_ipc_do(session_ipc_t *ipc)
+{
+	int error = 0;
+
+	switch(ipc->op)
+	{
+	case IPC_GET_PROCESS_SESSION_STATE:
+		ipc->ret = ASM_get_process_session_state(ipc->handle, &ipc->state, &error);
+		break;
+	case IPC_GET_SUBSESSION:
+		ipc->ret = ASM_get_subsession(ipc->handle, &ipc->subsession, &error, NULL);
+		break;
+	}
+	ipc->error = error;
+}
+
+static void _session_ipc_init(void)
+{
+	pthread_condattr_t attr;
+
+	/* wall clock change should not stretch or shrink timeout */
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&g_ipc_cond, &attr);
+	pthread_condattr_destroy(&attr);
+}
+
+/* caller should hold g_ipc_lock */
+static session_ipc_t* _session_ipc_find_pending(int handle)
+{
+	session_ipc_t *req = NULL;
+
+	for(req = g_ipc_pending; req; req = req->next) {
+		if(req->handle == handle)
+			return req;
+	}
+	return NULL;
+}
+
+/* caller should hold g_ipc_lock */
+static void _session_ipc_remove_pending(session_ipc_t *ipc)
+{
+	session_ipc_t **link = NULL;
+
+	for(link = &g_ipc_pending; *link; link = &(*link)->next) {
+		if(*link == ipc) {
+			*link = ipc->next;
+			break;
+		}
+	}
+}
+
+static void* _session_ipc_thread(void *data)
+{
+	session_ipc_t *ipc = (session_ipc_t*)data;
+	session_ipc_t result = *ipc;
+	int unregister = 0;
+	int release = 0;
+	int error = 0;
+
+	_session_ipc_do(&result);
+
+	pthread_mutex_lock(&g_ipc_lock);
+	ipc->ret = result.ret;
+	ipc->error = result.error;
+	ipc->state = result.state;
+	ipc->subsession = result.subsession;
+	ipc->done = 1;
+	_session_ipc_remove_pending(ipc);
+	unregister = ipc->unregister;
+	release = (--ipc->refcount == 0);
+	pthread_cond_broadcast(&g_ipc_cond);
+	pthread_mutex_unlock(&g_ipc_lock);
+
+	/* unregister requested while this call was in flight, handle is free now */
+	if(unregister && !ASM_unregister_sound(ipc->handle, ipc->unregister_event, &error))
+		debug_error("deferred ASM unregister of handle %d failed with %d", ipc->handle, error);
+
+	if(release)
+		free(ipc);
+
+	return NULL;
+}
+
+/* unregisters handle, or leaves it to worker if timed out call still uses it */
+static int _session_ipc_unregister(int handle, ASM_sound_events_t event)
+{
+	session_ipc_t *req = NULL;
+	int error = 0;
+
+	pthread_mutex_lock(&g_ipc_lock);
+	req = _session_ipc_find_pending(handle);
+	if(req) {
+		req->unregister = 1;
+		req->unregister_event = event;
+	}
+	pthread_mutex_unlock(&g_ipc_lock);
+
+	if(req) {
+		debug_warning("handle %d is busy, unregister is deferred", handle);
+		return 1;
+	}
+
+	return ASM_unregister_sound(handle, event, &error);
+}
+
+/* runs blocking ASM call within IPC timeout. returns 0 if it did not complete in time */
+static int _session_ipc_call(session_ipc_t *ipc)
+{
+	session_ipc_t *req = NULL;
+	pthread_attr_t attr;
+	pthread_t thread;
+	struct timespec ts;
+	unsigned int timeout = 0;
+	int done = 0;
+	int busy = 0;
+	int release = 0;
+	int ret = 0;
+
+	pthread_once(&g_ipc_once, _session_ipc_init);
+
+	pthread_mutex_lock(&g_ipc_lock);
+	timeout = g_ipc_timeout;
+	busy = (_session_ipc_find_pending(ipc->handle) != NULL);
+	pthread_mutex_unlock(&g_ipc_lock);
+
+	if(busy) {
+		/* previous call on this handle has not returned, do not share the channel */
+		debug_error("ASM handle %d is busy with timed out call", ipc->handle);
+		goto TIMEOUT;
+	}
+
+	if(timeout == 0) {
+		_session_ipc_do(ipc);
+		return 1;
+	}
+
+	req = (session_ipc_t*)malloc(sizeof(session_ipc_t));
+	if(req == NULL) {
+		_session_ipc_do(ipc);
+		return 1;
+	}
+	*req = *ipc;
+	req->done = 0;
+	req->refcount = 2;
+	req->unregister = 0;
+	req->next = NULL;
+
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+	ret = pthread_create(&thread, &attr, _session_ipc_thread, req);
+	pthread_attr_destroy(&attr);
+	if(ret) {
+		debug_warning("pthread_create() failed with %d, call without timeout", ret);
+		free(req);
+		_session_ipc_do(ipc);
+		return 1;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	ts.tv_sec += timeout / 1000;
+	ts.tv_nsec += (long)(timeout % 1000) * 1000000L;
+	if(ts.tv_nsec >= 1000000000L) {
+		ts.tv_sec++;
+		ts.tv_nsec -= 1000000000L;
+	}
+
+	pthread_mutex_lock(&g_ipc_lock);
+	while(!req->done) {
+		if(ETIMEDOUT == pthread_cond_timedwait(&g_ipc_cond, &g_ipc_lock, &ts))
+			break;
+	}
+	done = req->done;
+	if(done) {
+		ipc->ret = req->ret;
+		ipc->error = req->error;
+		ipc->state = req->state;
+		ipc->subsession = req->subsession;
+	} else {
+		/* worker is still blocked on this handle, mark it busy until reply */
+		req->next = g_ipc_pending;
+		g_ipc_pending = req;
+	}
+	release = (--req->refcount == 0);
+	pthread_mutex_unlock(&g_ipc_lock);
+
+	if(release)
+		free(req);
+
+	if(done)
+		return 1;
+
+	debug_error("ASM call %d did not complete in %u ms", ipc->op, timeout);
+
+TIMEOUT:
+	pthread_mutex_lock(&g_lookup_lock);
+	g_stats.ipc_timeouts++;
+	pthread_mutex_unlock(&g_lookup_lock);
+
+	return 0;
+}
+
+static void _session_ipc_count_fallback(void)
+{
+	pthread_mutex_lock(&g_lookup_lock);
+	g_stats.ipc_cached_fallbacks++;
+	pthread_mutex_unlock(&g_lookup_lock);
+}
+
+static int _session_snapshot_add(pid_t pid, void *data)
+{
+	session_snapshot_t *snapshot = (session_snapshot_t*)data;
+	char filename[MAX_FILE_LENGTH];
+	mm_session_record_t *record = NULL;
+	session_record_t value = { -1, -1, 0 };
+	struct stat st;
+	ssize_t length;
+	int fd = -1;
+
+	_session_record_name(filename, sizeof(filename), pid);
+	fd = openat(snapshot->dirfd, filename, O_RDONLY | O_CLOEXEC);
+	if(fd < 0)
+		return 0;	/* removed while scanning */
+	length = read(fd, &value, sizeof(value));
+	if(0 > fstat(fd, &st) || length < (ssize_t)sizeof(int)) {
+		close(fd);
+		return 0;
+	}
+	close(fd);
+
+	if(snapshot->count == snapshot->size) {
+		int size = snapshot->size ? snapshot->size * 2 : SNAPSHOT_INITIAL_SIZE;
+		mm_session_record_t *records = (mm_session_record_t*)realloc(snapshot->records, size * sizeof(mm_session_record_t));
+		if(records == NULL) {
+			snapshot->error = MM_ERROR_OUT_OF_MEMORY;
+			return 1;
+		}
+		snapshot->records = records;
+		snapshot->size = size;
+	}
+
+	record = &snapshot->records[snapshot->count++];
+	record->pid = pid;
+	record->sessiontype = value.sessiontype;
+	record->subsession = (length >= (ssize_t)offsetof(session_record_t, started)) ? value.subsession : -1;
+	/* records of older library have no start time */
+	record->started = (length >= (ssize_t)sizeof(value)) ? (time_t)value.started : st.st_mtime;
+	record->alive = _session_pid_alive(pid);
+
+	return 0;
+}
+
+EXPORT_API
+int mm_session_snapshot(mm_session_record_t **records, int *count)
+{
+	session_snapshot_t snapshot = {0,};
+	int result = MM_ERROR_NONE;
+
+	if(records == NULL || count == NULL)
+		return MM_ERROR_INVALID_ARGUMENT;
+
+	_session_fork_publish_pending(1);
+	snapshot.dirfd = _session_state_dirfd();
+	snapshot.error = MM_ERROR_NONE;
+	result = _session_scan_records(_session_snapshot_add, &snapshot);
+	if(MM_ERROR_NONE == result)
+		result = snapshot.error;
+	if(MM_ERROR_NONE != result) {
+		free(snapshot.records);
+		return result;
+	}
+
+	*records = snapshot.records;
+	*count = snapshot.count;
+
+	return MM_ERROR_NONE;
+}
+
+EXPORT_API
+void mm_session_snapshot_free(mm_session_record_t *records)
+{
+	free(records);
+}
+
+EXPORT_API
+const char* mm_session_type_name(int sessiontype)
+{
+	const session_type_desc_t *desc = _session_type_desc(sessiontype);
+
+	return desc ? desc->name : NULL;
+}
+
+EXPORT_API
+int mm_session_set_ipc_timeout(unsigned int msec)
+{
+	debug_log("timeout : %u", msec);
+
+	pthread_mutex_lock(&g_ipc_lock);
+	g_ipc_timeout = msec;
+	pthread_mutex_unlock(&g_ipc_lock);
+
+	return MM_ERROR_NONE;
+}
+
+static gboolean _session_watch_move_cb(gpointer data);
+
+EXPORT_API
+int mm_session_set_state_dir(const char *path)
+{
+	int fd = -1;
+	debug_log("path : %s", path ? path : "(null)");
+
+	if(path == NULL || path[0] == '\0' || strlen(path) >= sizeof(g_state_dir))
+		return MM_ERROR_INVALID_ARGUMENT;
+
+	fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if(fd < 0) {
+		debug_error("open(%s) failed with %d", path, errno);
+		return MM_ERROR_FILE_NOT_FOUND;
+	}
+
+	pthread_mutex_lock(&g_state_dir_lock);
+	if(g_state_dir_fd == -1) {
+		g_state_dir_fd = fd;
+	} else {
+		/* other threads may be using cached descriptor, so it is replaced in place and never closed */
+		if(0 > dup3(fd, g_state_dir_fd, O_CLOEXEC)) {
+			debug_error("dup3() failed with %d", errno);
+			pthread_mutex_unlock(&g_state_dir_lock);
+			close(fd);
+			return MM_ERROR_POLICY_INTERNAL;
+		}
+		close(fd);
+	}
+	snprintf(g_state_dir, sizeof(g_state_dir), "%s", path);
+	pthread_mutex_unlock(&g_state_dir_lock);
+
+	pthread_mutex_lock(&g_lookup_lock);
+	memset(g_lookup_cache, 0, sizeof(g_lookup_cache));
+	pthread_mutex_unlock(&g_lookup_lock);
+
+	/* running watch belongs to default main context, it moves there */
+	g_idle_add(_session_watch_move_cb, NULL);
+
+	return MM_ERROR_NONE;
+}
+
+static void* _session_preconnect_thread(void *data)
+{
+	int error = 0;
+	int handle = -1;
+
+	/* first registration of process sets up connection with sound server */
+	if(!ASM_register_sound(-1, &handle, ASM_EVENT_MONITOR, ASM_STATE_NONE, NULL, NULL, ASM_RESOURCE_NONE, &error)) {
+		debug_warning("pre-connection failed with %d", error);
+		handle = -1;
+	}
+
+	pthread_mutex_lock(&g_preconnect_lock);
+	g_preconnect_asm_handle = handle;
+	g_preconnect_state = PRECONNECT_DONE;
+	pthread_cond_broadcast(&g_preconnect_cond);
+	pthread_mutex_unlock(&g_preconnect_lock);
+
+	return NULL;
+}
+
+/* caller should hold g_preconnect_lock, it is released while waiting so fork is not blocked by sound server */
+static void _session_preconnect_join(void)
+{
+	while(g_preconnect_state == PRECONNECT_RUNNING)
+		pthread_cond_wait(&g_preconnect_cond, &g_preconnect_lock);
+}
+
+/* waits for pre-connection, its handle stays for later mm_session_finish or exit */
+static void _session_preconnect_wait(void)
+{
+	pthread_mutex_lock(&g_preconnect_lock);
+	_session_preconnect_join();
+	pthread_mutex_unlock(&g_preconnect_lock);
+}
+
+/* returns monitor handle registered by pre-connection only once, or -1 */
+static int _session_preconnect_take(int wait)
+{
+	int handle = -1;
+
+	pthread_mutex_lock(&g_preconnect_lock);
+	if(wait)
+		_session_preconnect_join();
+	if(g_preconnect_state == PRECONNECT_DONE) {
+		handle = g_preconnect_asm_handle;
+		g_preconnect_asm_handle = -1;
+	}
+	pthread_mutex_unlock(&g_preconnect_lock);
+
+	return handle;
+}
+
+EXPORT_API
+int mm_session_preconnect(void)
+{
+	pthread_attr_t attr;
+	pthread_t thread;
+	int result = MM_ERROR_NONE;
+	int ret;
+	debug_log("");
+
+	pthread_mutex_lock(&g_preconnect_lock);
+	if(g_preconnect_state == PRECONNECT_NONE && g_call_asm_handle == -1 && g_monitor_asm_handle == -1) {
+		pthread_attr_init(&attr);
+		pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+		ret = pthread_create(&thread, &attr, _session_preconnect_thread, NULL);
+		pthread_attr_destroy(&attr);
+		if(ret) {
+			debug_error("pthread_create() failed with %d", ret);
+			result = MM_ERROR_POLICY_INTERNAL;
+		} else {
+			g_preconnect_state = PRECONNECT_RUNNING;
+		}
+	}
+	pthread_mutex_unlock(&g_preconnect_lock);
+
+	return result;
+}
+
+/* reads record without lookup cache, for scans touching every record once */
+static int _session_record_read_type(int dirfd, pid_t pid, int *sessiontype)
+{
+	char filename[MAX_FILE_LENGTH];
+	int fd = -1;
+
+	_session_record_name(filename, sizeof(filename), pid);
+	fd = openat(dirfd, filename, O_RDONLY | O_CLOEXEC);
+	if(fd < 0)
+		return MM_ERROR_INVALID_HANDLE;
+	if(sizeof(int) != read(fd, sessiontype, sizeof(int))) {
+		close(fd);
+		return MM_ERROR_INVALID_HANDLE;
+	}
+	close(fd);
+
+	return MM_ERROR_NONE;
+}
+
+static int _session_find_call(pid_t pid, void *data)
+{
+	const session_type_desc_t *desc = NULL;
+	int sessiontype = -1;
+	int dirfd = -1;
+
+	if(pid == getpid())
+		return 0;
+	dirfd = _session_state_dirfd();
+	if(dirfd < 0 || MM_ERROR_NONE != _session_record_read_type(dirfd, pid, &sessiontype))
+		return 0;
+
+	desc = _session_type_desc(sessiontype);
+	if(desc == NULL || !desc->call_handle || !_session_pid_alive(pid))
+		return 0;
+
+	*(pid_t*)data = pid;
+	return 1;
+}
+
+EXPORT_API
+int mm_session_can_init(int sessiontype, mm_session_admit_reason_t *reason)
+{
+	const session_type_desc_t *desc = NULL;
+	mm_session_admit_reason_t admit = MM_SESSION_ADMIT_OK;
+	char filename[MAX_FILE_LENGTH];
+	pid_t call_pid = 0;
+	struct stat st;
+	int dirfd = -1;
+	int result = MM_ERROR_NONE;
+	debug_log("type : %d", sessiontype);
+
+	_session_fork_publish_pending(1);
+
+	desc = _session_type_desc(sessiontype);
+	if(desc == NULL) {
+		admit = MM_SESSION_ADMIT_INVALID_TYPE;
+		result = MM_ERROR_INVALID_ARGUMENT;
+		goto EXIT;
+	}
+
+	dirfd = _session_state_dirfd();
+	_session_record_name(filename, sizeof(filename), getpid());
+	if(dirfd >= 0 && 0 == fstatat(dirfd, filename, &st, 0)) {
+		admit = MM_SESSION_ADMIT_DUPLICATED;
+		result = MM_ERROR_POLICY_DUPLICATED;
+		goto EXIT;
+	}
+
+	/* advisory only, init_ex leaves call conflict to sound server */
+	if(desc->call_handle) {
+		_session_scan_records(_session_find_call, &call_pid);
+		if(call_pid > 0) {
+			debug_log("call session of pid %d is active", call_pid);
+			admit = MM_SESSION_ADMIT_CALL_ACTIVE;
+			result = MM_ERROR_POLICY_BLOCKED;
+		}
+	}
+
+EXIT:
+	if(reason)
+		*reason = admit;
+
+	return result;
+}
+
+/* after return, callback is not called again and not running on other thread.
+ * callback finishing its own session is still running in caller's stack */
+static void _session_monitor_clear(void)
+{
+	pthread_mutex_lock(&g_monitor_lock);
+	g_monitor_data.fn = NULL;
+	g_monitor_data.data = NULL;
+	while(g_monitor_dispatching && !pthread_equal(g_monitor_dispatch_thread, pthread_self()))
+		pthread_cond_wait(&g_monitor_cond, &g_monitor_lock);
+	pthread_mutex_unlock(&g_monitor_lock);
+}
+
 EXPORT_API
 int mm_session_init(int sessiontype)
 {
@@ -66,12 +1059,12 @@ int mm_session_init_ex(int sessiontype, session_callback_fn callback, void* user
 	int error = 0;
 	int result = MM_ERROR_NONE;
 	int ltype = 0;
+	const session_type_desc_t *desc = NULL;
 
 	debug_log("type : %d", sessiontype);
 
-	if(sessiontype != MM_SESSION_TYPE_SHARE && sessiontype != MM_SESSION_TYPE_EXCLUSIVE &&
-			sessiontype != MM_SESSION_TYPE_NOTIFY && sessiontype != MM_SESSION_TYPE_CALL && sessiontype != MM_SESSION_TYPE_ALARM  && sessiontype != MM_SESSION_TYPE_VIDEOCALL
-			&& sessiontype != MM_SESSION_TYPE_RICH_CALL) {
+	desc = _session_type_desc(sessiontype);
+	if(desc == NULL) {
 		debug_error("Invalid argument %d",sessiontype);
 		return MM_ERROR_INVALID_ARGUMENT;
 	}
@@ -82,18 +1075,17 @@ int mm_session_init_ex(int sessiontype, session_callback_fn callback, void* user
 		return MM_ERROR_POLICY_DUPLICATED;
 	}
 
-	if(sessiontype == MM_SESSION_TYPE_CALL) {
-		if(!ASM_register_sound(-1, &g_call_asm_handle, ASM_EVENT_CALL, ASM_STATE_PLAYING, NULL, NULL, ASM_RESOURCE_NONE, &error)) {
-			debug_error("Can not register sound");
-			return MM_ERROR_INVALID_HANDLE;
-		}
-	} else if(sessiontype == MM_SESSION_TYPE_VIDEOCALL) {
-		if(!ASM_register_sound(-1, &g_call_asm_handle, ASM_EVENT_VIDEOCALL, ASM_STATE_PLAYING, NULL, NULL, ASM_RESOURCE_CAMERA|ASM_RESOURCE_VIDEO_OVERLAY, &error))	{
-			debug_error("Can not register sound");
-			return MM_ERROR_INVALID_HANDLE;
-		}
-	} else if(sessiontype == MM_SESSION_TYPE_RICH_CALL) {
-		if(!ASM_register_sound(-1, &g_call_asm_handle, ASM_EVENT_RICH_CALL, ASM_STATE_PLAYING, NULL, NULL, ASM_RESOURCE_NONE, &error)) {
+	if(!desc->call_handle && NULL == callback && g_monitor_asm_handle == -1) {
+		/* this path makes no sound server call, so pre-connected monitor is adopted only if it is ready.
+		 * otherwise it is left for mm_session_finish or released at exit */
+		g_monitor_asm_handle = _session_preconnect_take(0);
+	} else {
+		/* pre-connected handle is not needed now, it is left for mm_session_finish or released at exit */
+		_session_preconnect_wait();
+	}
+
+	if(desc->call_handle) {
+		if(!ASM_register_sound(-1, &g_call_asm_handle, desc->event, desc->state, NULL, NULL, desc->resource, &error)) {
 			debug_error("Can not register sound");
 			return MM_ERROR_INVALID_HANDLE;
 		}
@@ -101,10 +1093,13 @@ int mm_session_init_ex(int sessiontype, session_callback_fn callback, void* user
 		if(NULL == callback) {
 			debug_warning("Null callback function");
 		} else {
+			pthread_mutex_lock(&g_monitor_lock);
 			g_monitor_data.fn = callback;
 			g_monitor_data.data = user_param;
-			if(!ASM_register_sound(-1, &g_monitor_asm_handle, ASM_EVENT_MONITOR, ASM_STATE_NONE, asm_monitor_callback, (void*)&g_monitor_data, ASM_RESOURCE_NONE, &error)) {
+			pthread_mutex_unlock(&g_monitor_lock);
+			if(!ASM_register_sound(-1, &g_monitor_asm_handle, desc->event, desc->state, asm_monitor_callback, (void*)&g_monitor_data, desc->resource, &error)) {
 				debug_error("Can not register monitor");
+				_session_monitor_clear();
 				return MM_ERROR_INVALID_HANDLE;
 			}
 		}
@@ -113,18 +1108,29 @@ int mm_session_init_ex(int sessiontype, session_callback_fn callback, void* user
 	result = _mm_session_util_write_type(-1, sessiontype);
 	if(MM_ERROR_NONE != result) {
 		debug_error("Write type failed");
-		if(sessiontype == MM_SESSION_TYPE_CALL) {
-			ASM_unregister_sound(g_call_asm_handle, ASM_EVENT_CALL, &error);
-		} else if(sessiontype == MM_SESSION_TYPE_VIDEOCALL) {
-			ASM_unregister_sound(g_call_asm_handle, ASM_EVENT_VIDEOCALL, &error);
-		} else if(sessiontype == MM_SESSION_TYPE_RICH_CALL) {
-			ASM_unregister_sound(g_call_asm_handle, ASM_EVENT_RICH_CALL, &error);
-		} else {
+		if(desc->call_handle) {
+			ASM_unregister_sound(g_call_asm_handle, desc->event, &error);
+			g_call_asm_handle = -1;
+		} else if(g_monitor_asm_handle != -1) {
 			ASM_unregister_sound(g_monitor_asm_handle, ASM_EVENT_MONITOR, &error);
+			g_monitor_asm_handle = -1;
 		}
+		_session_monitor_clear();
 		return result;
 	}
 
+	g_session_type = sessiontype;
+
+	return MM_ERROR_NONE;
+}
+
+EXPORT_API
+int mm_session_set_fork_inherit(int enable)
+{
+	debug_log("enable : %d", enable);
+
+	g_fork_inherit = enable ? 1 : 0;
+
 	return MM_ERROR_NONE;
 }
 
@@ -135,9 +1141,14 @@ int mm_session_finish()
 	int result = MM_ERROR_NONE;
 	int sessiontype = MM_SESSION_TYPE_SHARE;
 	ASM_sound_states_t state = ASM_STATE_NONE;
+	session_ipc_t ipc = {0,};
+	const session_type_desc_t *desc = NULL;
 	debug_log("");
 
 	if(g_call_asm_handle == -1) {
+		if(g_monitor_asm_handle == -1)
+			g_monitor_asm_handle = _session_preconnect_take(1);
+
 		if(g_monitor_asm_handle == -1) {
 			//register monitor handle to get MSL status of caller process
 			if(!ASM_register_sound(-1, &g_monitor_asm_handle, ASM_EVENT_MONITOR, ASM_STATE_NONE, NULL, NULL, ASM_RESOURCE_NONE, &error)) {
@@ -146,10 +1157,25 @@ int mm_session_finish()
 			}
 		}
 
-		if(!ASM_get_process_session_state(g_monitor_asm_handle, &state, &error)) {
+		ipc.op = IPC_GET_PROCESS_SESSION_STATE;
+		ipc.handle = g_monitor_asm_handle;
+		if(!_session_ipc_call(&ipc)) {
+			if(!g_last_state_valid)
+				return MM_ERROR_SESSION_IPC_TIMEOUT;
+			debug_warning("[%s] Use last process status %d", __func__, g_last_state);
+			_session_ipc_count_fallback();
+			ipc.ret = 1;
+			ipc.state = g_last_state;
+		}
+		state = ipc.state;
+
+		if(!ipc.ret) {
 			debug_error("[%s] Can not get process status", __func__);
 			return MM_ERROR_POLICY_INTERNAL;
 		} else {
+			g_last_state = state;
+			g_last_state_valid = 1;
+
 			switch(state)
 			{
 			case ASM_STATE_IGNORE:
@@ -173,27 +1199,16 @@ int mm_session_finish()
 		return result;
 	}
 
-	if(sessiontype == MM_SESSION_TYPE_CALL) {
-		if(!ASM_unregister_sound(g_call_asm_handle, ASM_EVENT_CALL, &error)) {
-			debug_error("\"CALL\" ASM unregister failed");
-			return MM_ERROR_INVALID_HANDLE;
-		}
-		g_call_asm_handle = -1;
-	} else if(sessiontype == MM_SESSION_TYPE_VIDEOCALL) {
-		if(!ASM_unregister_sound(g_call_asm_handle, ASM_EVENT_VIDEOCALL, &error)) {
-			debug_error("\"VIDEOCALL\" ASM unregister failed");
-			return MM_ERROR_INVALID_HANDLE;
-		}
-		g_call_asm_handle = -1;
-	} else if(sessiontype == MM_SESSION_TYPE_RICH_CALL) {
-		if(!ASM_unregister_sound(g_call_asm_handle, ASM_EVENT_RICH_CALL, &error)) {
-			debug_error("\"RICH-CALL\" ASM unregister failed");
+	desc = _session_type_desc(sessiontype);
+	if(desc && desc->call_handle) {
+		if(!_session_ipc_unregister(g_call_asm_handle, desc->event)) {
+			debug_error("\"%s\" ASM unregister failed", desc->name);
 			return MM_ERROR_INVALID_HANDLE;
 		}
 		g_call_asm_handle = -1;
 	} else {
 		if(g_monitor_asm_handle != -1) { //TODO :: this is trivial check. this should be removed later.
-			if(!ASM_unregister_sound(g_monitor_asm_handle, ASM_EVENT_MONITOR, &error)) {
+			if(!_session_ipc_unregister(g_monitor_asm_handle, ASM_EVENT_MONITOR)) {
 				debug_error("ASM unregister failed");
 				return MM_ERROR_INVALID_HANDLE;
 			}
@@ -201,6 +1216,14 @@ int mm_session_finish()
 		}
 	}
 
+	/* _asm_monitor_cb idle may still be pending or running, it should not call callback of finished session */
+	_session_monitor_clear();
+
+	/* cached values belong to finished session */
+	g_last_state_valid = 0;
+	g_last_subsession_valid = 0;
+	g_session_type = -1;
+
 	result = _mm_session_util_delete_type(-1);
 	if(result != MM_ERROR_NONE)
 		return result;
@@ -208,6 +1231,32 @@ int mm_session_finish()
 	return MM_ERROR_NONE;
 }
 
+/* only subsession field is written, so session type and start time are kept */
+static int _session_record_write_subsession(mm_subsession_t subsession)
+{
+	char filename[MAX_FILE_LENGTH];
+	int value = (int)subsession;
+	int dirfd = -1;
+	int fd = -1;
+	off_t offset = offsetof(session_record_t, subsession);
+
+	dirfd = _session_state_dirfd();
+	if(dirfd < 0)
+		return MM_ERROR_FILE_WRITE;
+
+	_session_record_name(filename, sizeof(filename), getpid());
+	fd = openat(dirfd, filename, O_WRONLY | O_CLOEXEC);
+	if(fd < 0)
+		return MM_ERROR_FILE_WRITE;
+	if(sizeof(int) != pwrite(fd, &value, sizeof(int), offset)) {
+		close(fd);
+		return MM_ERROR_FILE_WRITE;
+	}
+	close(fd);
+
+	return MM_ERROR_NONE;
+}
+
 EXPORT_API
 int mm_session_set_subsession (mm_subsession_t subsession)
 {
@@ -222,6 +1271,12 @@ int mm_session_set_subsession (mm_subsession_t subsession)
 
 	/* FIXME : Error handling */
 	ASM_set_subsession (g_call_asm_handle, subsession, &error, NULL);
+	g_last_subsession = subsession;
+	g_last_subsession_valid = 1;
+
+	result = _session_record_write_subsession(subsession);
+	if(MM_ERROR_NONE != result)
+		debug_warning("Can not write subsession to record");
 
 	return MM_ERROR_NONE;
 }
@@ -229,10 +1284,7 @@ int mm_session_set_subsession (mm_subsession_t subsession)
 EXPORT_API
 int mm_session_get_subsession (mm_subsession_t *subsession)
 {
-	int error = 0;
-	int result = MM_ERROR_NONE;
-	int sessiontype = MM_SESSION_TYPE_SHARE;
-	ASM_sound_states_t state = ASM_STATE_NONE;
+	session_ipc_t ipc = {0,};
 	debug_log("");
 
 	if(g_call_asm_handle == -1) {
@@ -240,7 +1292,18 @@ int mm_session_get_subsession (mm_subsession_t *subsession)
 		return MM_ERROR_INVALID_HANDLE;
 	}
 
-	ASM_get_subsession (g_call_asm_handle, subsession, &error, NULL);
+	ipc.op = IPC_GET_SUBSESSION;
+	ipc.handle = g_call_asm_handle;
+	if(_session_ipc_call(&ipc)) {
+		*subsession = ipc.subsession;
+		g_last_subsession = ipc.subsession;
+		g_last_subsession_valid = 1;
+	} else if(g_last_subsession_valid) {
+		_session_ipc_count_fallback();
+		*subsession = g_last_subsession;
+	} else {
+		return MM_ERROR_SESSION_IPC_TIMEOUT;
+	}
 
 	debug_log("ASM_get_subsession returned [%d]\n", *subsession);
 
@@ -251,6 +1314,7 @@ EXPORT_API
 int _mm_session_util_delete_type(int app_pid)
 {
 	pid_t mypid;
+	int dirfd = -1;
 	char filename[MAX_FILE_LENGTH];
 
 	if(app_pid == -1)
@@ -258,43 +1322,20 @@ int _mm_session_util_delete_type(int app_pid)
 	else
 		mypid = (pid_t)app_pid;
 
-	////// DELETE SESSION TYPE /////////
-	snprintf(filename, sizeof(filename)-1, "/tmp/mm_session_%d",mypid);
-	if(-1 ==  unlink(filename))
-		return MM_ERROR_FILE_NOT_FOUND;
-	////// DELETE SESSION TYPE /////////
-	EXPORT_API
-	int mm_session_finish() {
-		int error = 0;
-		int result = MM_ERROR_NONE;
-		int sessiontype = MM_SESSION_TYPE_SHARE;
-
-		result = _mm_session_util_read_type(-1, &sessiontype);
-		if(MM_ERROR_NONE != result) {
-			return result;
-		}
+	if(mypid == getpid())
+		_session_fork_publish_pending(0);
 
-		if(sessiontype == MM_SESSION_TYPE_CALL) {
-			if(!ASM_unregister_sound(g_call_asm_handle, ASM_EVENT_CALL, &error)) {
-				return MM_ERROR_INVALID_HANDLE;
-			}
-		} else if(sessiontype == MM_SESSION_TYPE_VIDEOCALL) {
-			if(!ASM_unregister_sound(g_call_asm_handle, ASM_EVENT_VIDEOCALL, &error)) {
-				return MM_ERROR_INVALID_HANDLE;
-			}
-		} else if(sessiontype == MM_SESSION_TYPE_RICH_CALL) {
-			if(!ASM_unregister_sound(g_call_asm_handle, ASM_EVENT_RICH_CALL, &error)) {
-				return MM_ERROR_INVALID_HANDLE;
-			}
-		}
+	dirfd = _session_state_dirfd();
+	if(dirfd < 0)
+		return MM_ERROR_FILE_NOT_FOUND;
 
-		result = _mm_session_util_delete_type(-1);
-		if(result != MM_ERROR_NONE)
-			return result;
-
-		return MM_ERROR_NONE;
-	}
+	_session_lookup_invalidate(mypid);
 
+	////// DELETE SESSION TYPE /////////
+	_session_record_name(filename, sizeof(filename), mypid);
+	if(-1 ==  unlinkat(dirfd, filename, 0))
+		return MM_ERROR_FILE_NOT_FOUND;
+	////// DELETE SESSION TYPE /////////
 
 	return MM_ERROR_NONE;
 }
@@ -304,12 +1345,12 @@ int _mm_session_util_write_type(int app_pid, int sessiontype)
 {
 	pid_t mypid;
 	int fd = -1;
+	int dirfd = -1;
 	char filename[MAX_FILE_LENGTH];
+	session_record_t record;
 	int res=0;
 
-	if(sessiontype != MM_SESSION_TYPE_SHARE && sessiontype != MM_SESSION_TYPE_EXCLUSIVE &&
-			sessiontype != MM_SESSION_TYPE_NOTIFY && sessiontype != MM_SESSION_TYPE_CALL && sessiontype != MM_SESSION_TYPE_ALARM
-			&& sessiontype != MM_SESSION_TYPE_RICH_CALL) {
+	if(_session_type_desc(sessiontype) == NULL) {
 		return MM_ERROR_INVALID_ARGUMENT;
 	}
 
@@ -318,14 +1359,26 @@ int _mm_session_util_write_type(int app_pid, int sessiontype)
 	else
 		mypid = (pid_t)app_pid;
 
+	if(mypid == getpid())
+		_session_fork_publish_pending(0);
+
+	dirfd = _session_state_dirfd();
+	if(dirfd < 0)
+		return MM_ERROR_FILE_WRITE;
+
+	_session_lookup_invalidate(mypid);
+
 	////// WRITE SESSION TYPE /////////
-	snprintf(filename, sizeof(filename)-1, "/tmp/mm_session_%d",mypid);
-	fd = open(filename, O_WRONLY | O_CREAT, 0644 );
+	_session_record_name(filename, sizeof(filename), mypid);
+	fd = openat(dirfd, filename, O_WRONLY | O_CREAT | O_CLOEXEC, 0644 );
 	if(fd < 0) {
 		debug_error("open() failed with %d",errno);
 		return MM_ERROR_FILE_WRITE;
 	}
-	write(fd, &sessiontype, sizeof(int));
+	record.sessiontype = sessiontype;
+	record.subsession = -1;
+	record.started = (long long)time(NULL);
+	write(fd, &record, sizeof(record));
 	if(0 > fchmod (fd, 00777)) {
 		debug_log("fchmod failed with %d", errno);
 	}
@@ -340,6 +1393,7 @@ int _mm_session_util_read_type(int app_pid, int *sessiontype)
 {
 	pid_t mypid;
 	int fd = -1;
+	int dirfd = -1;
 	char filename[MAX_FILE_LENGTH];
 
 	if(sessiontype == NULL)
@@ -350,9 +1404,19 @@ int _mm_session_util_read_type(int app_pid, int *sessiontype)
 	else
 		mypid = (pid_t)app_pid;
 
+	_session_fork_publish_pending(1);
+
+	dirfd = _session_state_dirfd();
+	if(dirfd < 0)
+		return MM_ERROR_INVALID_HANDLE;
+
+	/* other process's type is asked repeatedly by player side, so it is cached */
+	if(mypid != getpid())
+		return _session_lookup_read(dirfd, mypid, sessiontype);
+
 	////// READ SESSION TYPE /////////
-	snprintf(filename, sizeof(filename)-1, "/tmp/mm_session_%d",mypid);
-	fd = open(filename, O_RDONLY);
+	_session_record_name(filename, sizeof(filename), mypid);
+	fd = openat(dirfd, filename, O_RDONLY | O_CLOEXEC);
 	if(fd < 0) {
 		return MM_ERROR_INVALID_HANDLE;
 	}
@@ -363,13 +1427,353 @@ int _mm_session_util_read_type(int app_pid, int *sessiontype)
 	return MM_ERROR_NONE;
 }
 
+static void _session_watch_stop(void)
+{
+	if(g_watch_source) {
+		g_source_remove(g_watch_source);
+		g_watch_source = 0;
+	}
+	if(g_watch_channel) {
+		g_io_channel_unref(g_watch_channel);
+		g_watch_channel = NULL;
+	}
+	if(g_watch_fd != -1) {
+		close(g_watch_fd);
+		g_watch_fd = -1;
+	}
+	g_watch_wd = -1;
+	if(g_watch_known) {
+		g_hash_table_unref(g_watch_known);
+		g_watch_known = NULL;
+	}
+}
+
+static void _session_watch_purge(void)
+{
+	GList *list = g_watch_list;
+
+	while(list) {
+		GList *next = list->next;
+		session_watch_t *watch = (session_watch_t*)list->data;
+		if(watch->removed) {
+			g_free(watch);
+			g_watch_list = g_list_delete_link(g_watch_list, list);
+		}
+		list = next;
+	}
+
+	if(g_watch_list == NULL)
+		_session_watch_stop();
+}
+
+static void _session_watch_dispatch(int pid, mm_session_watch_event_t event, int sessiontype)
+{
+	GList *list;
+
+	g_watch_dispatching = 1;
+	for(list = g_watch_list; list; list = list->next) {
+		session_watch_t *watch = (session_watch_t*)list->data;
+		if(watch->removed)
+			continue;
+		if(watch->pid != MM_SESSION_WATCH_ALL_PID && watch->pid != pid)
+			continue;
+		watch->fn(pid, event, sessiontype, watch->data);
+	}
+	g_watch_dispatching = 0;
+
+	_session_watch_purge();
+}
+
+static int _session_watch_scan_add(pid_t pid, void *data)
+{
+	int sessiontype = -1;
+	int dirfd = _session_state_dirfd();
+
+	/* record being created has no type yet, CREATED is reported when it is written */
+	if(dirfd < 0 || MM_ERROR_NONE != _session_record_read_type(dirfd, pid, &sessiontype))
+		sessiontype = -1;
+	g_hash_table_replace((GHashTable*)data, GINT_TO_POINTER(pid), GINT_TO_POINTER(sessiontype));
+
+	return 0;
+}
+
+/* inotify queue overflowed and events are lost, so compare directory with known records */
+static void _session_watch_rescan(void)
+{
+	GHashTable *known = g_watch_known;
+	GHashTable *found = NULL;
+	GHashTableIter iter;
+	gpointer key, value, old;
+
+	found = g_hash_table_new(g_direct_hash, g_direct_equal);
+	if(MM_ERROR_NONE != _session_scan_records(_session_watch_scan_add, found)) {
+		g_hash_table_unref(found);
+		return;
+	}
+
+	/* dispatch may stop watching and unref g_watch_known, both tables are kept until done */
+	g_watch_known = g_hash_table_ref(found);
+
+	g_hash_table_iter_init(&iter, known);
+	while(g_watch_fd != -1 && g_hash_table_iter_next(&iter, &key, &value)) {
+		if(!g_hash_table_lookup_extended(found, key, NULL, NULL))
+			_session_watch_dispatch(GPOINTER_TO_INT(key), MM_SESSION_WATCH_DELETED, -1);
+	}
+
+	g_hash_table_iter_init(&iter, found);
+	while(g_watch_fd != -1 && g_hash_table_iter_next(&iter, &key, &value)) {
+		if(GPOINTER_TO_INT(value) == -1)
+			continue;
+		if(!g_hash_table_lookup_extended(known, key, NULL, &old) || GPOINTER_TO_INT(old) == -1)
+			_session_watch_dispatch(GPOINTER_TO_INT(key), MM_SESSION_WATCH_CREATED, GPOINTER_TO_INT(value));
+		else if(old != value)
+			_session_watch_dispatch(GPOINTER_TO_INT(key), MM_SESSION_WATCH_CHANGED, GPOINTER_TO_INT(value));
+	}
+
+	g_hash_table_unref(known);
+	g_hash_table_unref(found);
+}
+
+static gboolean _session_watch_rearm_cb(gpointer data);
+
+static gboolean _session_watch_io_cb(GIOChannel *channel, GIOCondition condition, gpointer data)
+{
+	char buf[WATCH_BUFFER_LENGTH] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+	const struct inotify_event *event = NULL;
+	ssize_t length;
+	char *ptr;
+
+	/* source inherited from parent by forked child, its descriptor is closed */
+	if(channel != g_watch_channel)
+		return FALSE;
+
+	if(condition & (G_IO_ERR | G_IO_HUP | G_IO_NVAL)) {
+		debug_error("inotify channel error, condition %d", condition);
+		/* source is removed by returning FALSE, inotify is armed again for remaining watches */
+		g_watch_source = 0;
+		if(g_watch_lost)
+			g_hash_table_unref(g_watch_lost);
+		g_watch_lost = g_watch_known;
+		g_watch_known = NULL;
+		_session_watch_stop();
+		g_timeout_add_seconds(WATCH_REARM_INTERVAL, _session_watch_rearm_cb, NULL);
+		return FALSE;
+	}
+
+	length = read(g_watch_fd, buf, sizeof(buf));
+	if(length <= 0)
+		return TRUE;
+
+	for(ptr = buf; ptr < buf + length; ptr += sizeof(struct inotify_event) + event->len) {
+		int pid;
+		int sessiontype = -1;
+		int dirfd = -1;
+		event = (const struct inotify_event*)ptr;
+
+		if(event->mask & IN_Q_OVERFLOW) {
+			debug_error("inotify queue overflow, rescan records");
+			_session_watch_rescan();
+			if(g_watch_fd == -1)
+				return FALSE;
+			continue;
+		}
+		if(event->len == 0)
+			continue;
+		pid = _session_record_pid(event->name);
+		if(pid < 0)
+			continue;
+
+		if(event->mask & IN_CREATE) {
+			/* file is empty yet, report it when writer closes it */
+			g_hash_table_replace(g_watch_known, GINT_TO_POINTER(pid), GINT_TO_POINTER(-1));
+		} else if(event->mask & IN_DELETE) {
+			g_hash_table_remove(g_watch_known, GINT_TO_POINTER(pid));
+			_session_watch_dispatch(pid, MM_SESSION_WATCH_DELETED, -1);
+		} else if(event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+			mm_session_watch_event_t type = MM_SESSION_WATCH_CHANGED;
+			gpointer old = NULL;
+			if((event->mask & IN_MOVED_TO) || !g_hash_table_lookup_extended(g_watch_known, GINT_TO_POINTER(pid), NULL, &old) ||
+					GPOINTER_TO_INT(old) == -1)
+				type = MM_SESSION_WATCH_CREATED;
+			/* lookup cache is kept for player side, every record written is read here once */
+			dirfd = _session_state_dirfd();
+			if(dirfd < 0 || MM_ERROR_NONE != _session_record_read_type(dirfd, pid, &sessiontype))
+				continue;
+			/* subsession update rewrites record with same type */
+			if(type == MM_SESSION_WATCH_CHANGED && GPOINTER_TO_INT(old) == sessiontype)
+				continue;
+			g_hash_table_replace(g_watch_known, GINT_TO_POINTER(pid), GINT_TO_POINTER(sessiontype));
+			_session_watch_dispatch(pid, type, sessiontype);
+		}
+
+		/* dispatch may drop the last watch and close inotify */
+		if(g_watch_fd == -1)
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+static int _session_watch_start(void)
+{
+	char dir[MAX_FILE_LENGTH];
+
+	if(g_watch_fd != -1)
+		return MM_ERROR_NONE;
+
+	pthread_mutex_lock(&g_state_dir_lock);
+	if(0 > _session_state_dir_resolve()) {
+		pthread_mutex_unlock(&g_state_dir_lock);
+		return MM_ERROR_INVALID_ARGUMENT;
+	}
+	snprintf(dir, sizeof(dir), "%s", g_state_dir);
+	pthread_mutex_unlock(&g_state_dir_lock);
+
+	g_watch_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if(g_watch_fd < 0) {
+		debug_error("inotify_init1() failed with %d", errno);
+		return MM_ERROR_POLICY_INTERNAL;
+	}
+
+	g_watch_wd = inotify_add_watch(g_watch_fd, dir, WATCH_EVENTS);
+	if(g_watch_wd < 0) {
+		debug_error("inotify_add_watch() failed with %d", errno);
+		_session_watch_stop();
+		return MM_ERROR_POLICY_INTERNAL;
+	}
+	snprintf(g_watch_dir, sizeof(g_watch_dir), "%s", dir);
+
+	/* records written before watch was added are known, so later writes are reported as changes */
+	g_watch_known = g_hash_table_new(g_direct_hash, g_direct_equal);
+	_session_scan_records(_session_watch_scan_add, g_watch_known);
+
+	g_watch_channel = g_io_channel_unix_new(g_watch_fd);
+	g_watch_source = g_io_add_watch(g_watch_channel, G_IO_IN | G_IO_ERR | G_IO_HUP, _session_watch_io_cb, NULL);
+
+	return MM_ERROR_NONE;
+}
+
+/* retried until inotify works again or all watches are removed */
+static gboolean _session_watch_rearm_cb(gpointer data)
+{
+	if(g_watch_list == NULL || g_watch_fd != -1) {
+		if(g_watch_lost) {
+			g_hash_table_unref(g_watch_lost);
+			g_watch_lost = NULL;
+		}
+		return FALSE;
+	}
+
+	if(MM_ERROR_NONE != _session_watch_start())
+		return TRUE;
+
+	/* changes while inotify was down are reported as after queue overflow */
+	if(g_watch_lost) {
+		g_hash_table_unref(g_watch_known);
+		g_watch_known = g_watch_lost;
+		g_watch_lost = NULL;
+		_session_watch_rescan();
+	}
+
+	return FALSE;
+}
+
+/* running watch follows state directory, records of new directory are taken as known without dispatch.
+ * watch state is only used in default main context, so this runs as idle there */
+static gboolean _session_watch_move_cb(gpointer data)
+{
+	char dir[MAX_FILE_LENGTH];
+
+	if(g_watch_fd == -1)
+		return FALSE;
+
+	pthread_mutex_lock(&g_state_dir_lock);
+	snprintf(dir, sizeof(dir), "%s", g_state_dir);
+	pthread_mutex_unlock(&g_state_dir_lock);
+	if(0 == strcmp(dir, g_watch_dir))
+		return FALSE;
+
+	if(g_watch_wd != -1)
+		inotify_rm_watch(g_watch_fd, g_watch_wd);
+	g_watch_wd = inotify_add_watch(g_watch_fd, dir, WATCH_EVENTS);
+	if(g_watch_wd < 0) {
+		debug_error("inotify_add_watch() failed with %d", errno);
+		return FALSE;
+	}
+	snprintf(g_watch_dir, sizeof(g_watch_dir), "%s", dir);
+
+	g_hash_table_unref(g_watch_known);
+	g_watch_known = g_hash_table_new(g_direct_hash, g_direct_equal);
+	_session_scan_records(_session_watch_scan_add, g_watch_known);
+
+	return FALSE;
+}
+
+EXPORT_API
+int mm_session_watch(int app_pid, session_watch_cb callback, void *user_param, int *watch_id)
+{
+	int result = MM_ERROR_NONE;
+	session_watch_t *watch = NULL;
+	debug_log("pid : %d", app_pid);
+
+	if(callback == NULL || watch_id == NULL)
+		return MM_ERROR_INVALID_ARGUMENT;
+
+	result = _session_watch_start();
+	if(MM_ERROR_NONE != result)
+		return result;
+
+	watch = g_new0(session_watch_t, 1);
+	watch->id = ++g_watch_last_id;
+	watch->pid = (app_pid == -1) ? getpid() : app_pid;
+	watch->fn = callback;
+	watch->data = user_param;
+	g_watch_list = g_list_append(g_watch_list, watch);
+
+	*watch_id = watch->id;
+
+	return MM_ERROR_NONE;
+}
+
+EXPORT_API
+int mm_session_unwatch(int watch_id)
+{
+	GList *list;
+	debug_log("id : %d", watch_id);
+
+	for(list = g_watch_list; list; list = list->next) {
+		session_watch_t *watch = (session_watch_t*)list->data;
+		if(watch->id == watch_id && !watch->removed) {
+			watch->removed = 1;
+			if(!g_watch_dispatching)
+				_session_watch_purge();
+			return MM_ERROR_NONE;
+		}
+	}
+
+	return MM_ERROR_INVALID_ARGUMENT;
+}
+
 gboolean _asm_monitor_cb(gpointer *data)
 {
 	session_monitor_t* monitor = (session_monitor_t*)data;
-	if (monitor) {
-		if (monitor->fn) {
-			monitor->fn(monitor->msg, monitor->event, monitor->data);
-		}
+	session_monitor_t current = {0,};
+
+	pthread_mutex_lock(&g_monitor_lock);
+	if (monitor && monitor->fn) {
+		current = *monitor;
+		g_monitor_dispatching = 1;
+		g_monitor_dispatch_thread = pthread_self();
+	}
+	pthread_mutex_unlock(&g_monitor_lock);
+
+	if (current.fn) {
+		current.fn(current.msg, current.event, current.data);
+
+		pthread_mutex_lock(&g_monitor_lock);
+		g_monitor_dispatching = 0;
+		pthread_cond_broadcast(&g_monitor_cond);
+		pthread_mutex_unlock(&g_monitor_lock);
 	}
 
 	return FALSE;
@@ -442,13 +1846,78 @@ asm_monitor_callback(int handle, ASM_event_sources_t event_src, ASM_sound_comman
 	return cb_res;
 }
 
+static void _session_fork_prepare(void)
+{
+	pthread_mutex_lock(&g_fork_lock);
+	pthread_mutex_lock(&g_state_dir_lock);
+	pthread_mutex_lock(&g_preconnect_lock);
+	pthread_mutex_lock(&g_ipc_lock);
+	pthread_mutex_lock(&g_lookup_lock);
+	pthread_mutex_lock(&g_monitor_lock);
+}
+
+static void _session_fork_parent(void)
+{
+	pthread_mutex_unlock(&g_monitor_lock);
+	pthread_mutex_unlock(&g_lookup_lock);
+	pthread_mutex_unlock(&g_ipc_lock);
+	pthread_mutex_unlock(&g_preconnect_lock);
+	pthread_mutex_unlock(&g_state_dir_lock);
+	pthread_mutex_unlock(&g_fork_lock);
+}
+
+static void _session_fork_child(void)
+{
+	const session_type_desc_t *desc = NULL;
+
+	_session_fork_parent();
+
+	/* ASM handles and threads of parent are not valid for child pid */
+	g_call_asm_handle = -1;
+	g_monitor_asm_handle = -1;
+	memset(&g_monitor_data, 0, sizeof(g_monitor_data));
+	g_monitor_dispatching = 0;	/* main loop of parent does not run in child */
+	pthread_cond_init(&g_monitor_cond, NULL);
+	g_preconnect_state = PRECONNECT_NONE;
+	g_preconnect_asm_handle = -1;
+	pthread_cond_init(&g_preconnect_cond, NULL);	/* waiters of parent do not exist in child */
+	g_last_state_valid = 0;
+	g_last_subsession_valid = 0;
+	g_ipc_pending = NULL;	/* workers of parent do not exist in child */
+
+	/* inotify of parent is not shared, watch memory is dropped without free as malloc is not safe here */
+	if(g_watch_fd != -1)
+		close(g_watch_fd);
+	g_watch_fd = -1;
+	g_watch_wd = -1;
+	g_watch_channel = NULL;
+	g_watch_source = 0;
+	g_watch_list = NULL;
+	g_watch_known = NULL;
+	g_watch_lost = NULL;
+	g_watch_dispatching = 0;
+
+	/* call types own ASM handle, so they can not be inherited without registration */
+	desc = _session_type_desc(g_session_type);
+	if(g_fork_inherit && desc && !desc->call_handle)
+		g_fork_publish = 1;
+	else
+		g_session_type = -1;
+}
+
 __attribute__ ((destructor))
 void __mmsession_finalize(void)
 {
 	int error=0;
+	int warm_handle = -1;
+
+	/* do not wait for sound server at exit */
+	warm_handle = _session_preconnect_take(0);
+	if(warm_handle != -1)
+		ASM_unregister_sound(warm_handle, ASM_EVENT_MONITOR, &error);
 
 	if(g_monitor_asm_handle != -1) {
-		if(!ASM_unregister_sound(g_monitor_asm_handle, ASM_EVENT_MONITOR, &error)) {
+		if(!_session_ipc_unregister(g_monitor_asm_handle, ASM_EVENT_MONITOR)) {
 			debug_error("ASM unregister failed");
 		}
 		g_monitor_asm_handle = -1;
@@ -459,6 +1928,19 @@ void __mmsession_finalize(void)
 __attribute__ ((constructor))
 void __mmsession_initialize(void)
 {
+	const char *env = getenv(PRECONNECT_ENV);
+
+	if(env && atoi(env) > 0)
+		mm_session_preconnect();
+
+	env = getenv(IPC_TIMEOUT_ENV);
+	if(env && atoi(env) > 0)
+		mm_session_set_ipc_timeout((unsigned int)atoi(env));
+
+	env = getenv(FORK_INHERIT_ENV);
+	if(env && atoi(env) > 0)
+		mm_session_set_fork_inherit(1);
 
+	pthread_atfork(_session_fork_prepare, _session_fork_parent, _session_fork_child);
 }
 
@@ -0,0 +1,204 @@
+/*
+ * libmm-session
+ *
+ * Copyright (c) 2000 - 2011 Samsung Electronics Co., Ltd. All rights reserved.
+ *
+ * Contact: Seungbae Shin <seungbae.shin@samsung.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/**
+ * This file declares C++ wrapper of multimedia framework session.
+ *
+ * @file		mm_session.hpp
+ * @author
+ * @version		1.0
+ * @brief		This file declares header-only C++ RAII wrapper of mm_session.h (C++11 or later).
+ */
+#ifndef	_MM_SESSION_HPP_
+#define	_MM_SESSION_HPP_
+
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include <mm_error.h>
+#include <mm_session.h>
+
+namespace mm {
+
+/**
+  * Result of session operation, holds error code of underlying C API.
+  */
+class session_result {
+public:
+	explicit session_result(int code = MM_ERROR_NONE) noexcept : code_(code) {}
+
+	bool ok() const noexcept { return code_ == MM_ERROR_NONE; }
+	explicit operator bool() const noexcept { return ok(); }
+	int code() const noexcept { return code_; }
+
+private:
+	int code_;
+};
+
+namespace detail {
+
+template <typename F>
+struct session_callback {
+	/* passed to mm_session_init_ex() as session_callback_fn, callable is inlined here */
+	static void invoke(session_msg_t msg, session_event_t event, void *user_param) noexcept
+	{
+		(*static_cast<F*>(user_param))(msg, event);
+	}
+
+	static void destroy(void *callable) noexcept
+	{
+		delete static_cast<F*>(callable);
+	}
+};
+
+} /* namespace detail */
+
+/**
+  * Move-only owner of caller process's session.
+  * Session is finished when owner is destroyed.
+  *
+  * @par Example
+  * @code
+#include <mm_session.hpp>
+
+mm::session session;
+mm::session_result ret = session.init(MM_SESSION_TYPE_SHARE,
+		[ad](session_msg_t msg, session_event_t event) {
+			if (msg == MM_SESSION_MSG_STOP)
+				stop_playback(ad);
+		});
+if (!ret)
+	printf("Can not initialize session 0x%x\n", ret.code());
+  * @endcode
+  */
+class session {
+public:
+	session() noexcept : active_(false), callable_(nullptr), destroy_(nullptr) {}
+
+	~session() { reset(); }
+
+	session(const session&) = delete;
+	session& operator=(const session&) = delete;
+
+	session(session &&other) noexcept
+		: active_(other.active_), callable_(other.callable_), destroy_(other.destroy_)
+	{
+		other.release();
+	}
+
+	session& operator=(session &&other) noexcept
+	{
+		if (this != &other) {
+			reset();
+			active_ = other.active_;
+			callable_ = other.callable_;
+			destroy_ = other.destroy_;
+			other.release();
+		}
+		return *this;
+	}
+
+	/**
+	  * Initializes session without callback, see mm_session_init().
+	  */
+	session_result init(int sessiontype) noexcept
+	{
+		if (active_)
+			return session_result(MM_ERROR_POLICY_DUPLICATED);
+
+		int ret = mm_session_init(sessiontype);
+		if (ret == MM_ERROR_NONE)
+			active_ = true;
+		return session_result(ret);
+	}
+
+	/**
+	  * Initializes session with callable invoked as fn(session_msg_t, session_event_t),
+	  * see mm_session_init_ex(). Callable should not throw.
+	  */
+	template <typename F>
+	session_result init(int sessiontype, F &&fn)
+	{
+		typedef typename std::decay<F>::type callable_t;
+
+		if (active_)
+			return session_result(MM_ERROR_POLICY_DUPLICATED);
+
+		/* if init fails or copying callable throws, nothing is registered and holder is freed */
+		std::unique_ptr<callable_t> holder(new callable_t(std::forward<F>(fn)));
+		int ret = mm_session_init_ex(sessiontype, &detail::session_callback<callable_t>::invoke, holder.get());
+		if (ret != MM_ERROR_NONE)
+			return session_result(ret);
+
+		callable_ = holder.release();
+		destroy_ = &detail::session_callback<callable_t>::destroy;
+		active_ = true;
+		return session_result();
+	}
+
+	/**
+	  * Finishes session, see mm_session_finish().
+	  * On failure session stays active and may be finished again.
+	  * On success library has dropped callback and waited for dispatch running on other thread,
+	  * so callable is not reached afterwards. Callable should not finish its own session.
+	  */
+	session_result finish() noexcept
+	{
+		if (!active_)
+			return session_result(MM_ERROR_INVALID_HANDLE);
+
+		int ret = mm_session_finish();
+		if (ret != MM_ERROR_NONE)
+			return session_result(ret);
+
+		if (destroy_)
+			destroy_(callable_);
+		release();
+		return session_result();
+	}
+
+	bool active() const noexcept { return active_; }
+
+private:
+	void release() noexcept
+	{
+		active_ = false;
+		callable_ = nullptr;
+		destroy_ = nullptr;
+	}
+
+	void reset() noexcept
+	{
+		if (active_ && !finish().ok()) {
+			/* library may still call registered callback, so callable is kept until process exit */
+			release();
+		}
+	}
+
+	bool active_;
+	void *callable_;
+	void (*destroy_)(void*);
+};
+
+} /* namespace mm */
+
+#endif
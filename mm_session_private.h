@@ -34,8 +34,15 @@
 extern "C" {
 #endif
 
+#include <time.h>
 #include <mm_session.h>
 
+/**
+  * Error code returned when sound server does not answer within IPC timeout
+  * and no last known value is available (see mm_session_set_ipc_timeout).
+  */
+#define MM_ERROR_SESSION_IPC_TIMEOUT	(MM_ERROR_POLICY_CLASS | 0x80)
+
 /**
   * This enumeration defines session types for internal usage.
   */
@@ -54,6 +61,132 @@ typedef enum {
 	MM_SUBSESSION_TYPE_MEDIA
 } mm_subsession_t;
 
+/**
+  * This enumeration defines session watch notification types.
+  */
+typedef enum {
+	MM_SESSION_WATCH_CREATED = 0,	/**< Session type of the process has been written first time */
+	MM_SESSION_WATCH_CHANGED,	/**< Session information of the process has been rewritten */
+	MM_SESSION_WATCH_DELETED,	/**< Session type of the process has been cleared */
+} mm_session_watch_event_t;
+
+/**
+  * This enumeration defines reasons of session admission check.
+  */
+typedef enum {
+	MM_SESSION_ADMIT_OK = 0,	/**< Session could be initialized */
+	MM_SESSION_ADMIT_INVALID_TYPE,	/**< Session type is not supported */
+	MM_SESSION_ADMIT_DUPLICATED,	/**< Caller process already has session */
+	MM_SESSION_ADMIT_CALL_ACTIVE,	/**< Call session of other process is active */
+} mm_session_admit_reason_t;
+
+#define MM_SESSION_WATCH_ALL_PID	0	/**< Watch session type changes of all processes */
+
+/**
+  * This structure holds internal counters of session library.
+  */
+typedef struct {
+	unsigned int lookup_hits;	/**< Other process's session type returned from lookup cache */
+	unsigned int lookup_misses;	/**< Other process's session type read from storage */
+	unsigned int lookup_recycled;	/**< Record left by exited process found for reused pid */
+	unsigned int ipc_timeouts;	/**< Sound server calls which exceeded IPC timeout */
+	unsigned int ipc_cached_fallbacks;	/**< Timed out calls answered from last known state */
+} mm_session_stats_t;
+
+/**
+  * This structure holds session information of a process.
+  */
+typedef struct {
+	int pid;	/**< Process id */
+	int sessiontype;	/**< Multimedia Session type */
+	int subsession;	/**< Sub-session type (mm_subsession_t), -1 if not set */
+	time_t started;	/**< Time session type was written, not changed by sub-session update */
+	int alive;	/**< Non-zero if process is still running */
+} mm_session_record_t;
+
+typedef void (*session_watch_cb) (int app_pid, mm_session_watch_event_t event, int sessiontype, void *user_param);
+
+/**
+ * This function checks whether session type could be initialized now
+ *
+ * @param	sessiontype	[in] Multimedia Session type
+ * @param	reason [out] reason of result (can be NULL)
+ *
+ * @return	This function returns MM_ERROR_NONE if session could be initialized,
+ *			MM_ERROR_INVALID_ARGUMENT or MM_ERROR_POLICY_DUPLICATED as mm_session_init_ex does,
+ *			or MM_ERROR_POLICY_BLOCKED if call type is requested while other process has call session.
+ * @remark	This function does not contact sound server and has no side effect,
+ * 			so application can choose other session type before calling mm_session_init_ex.
+ * 			Call conflict is advisory: mm_session_init_ex does not check it and
+ * 			sound server decides when call session is registered.
+ * @see		mm_session_init mm_session_init_ex
+ * @since
+ */
+int mm_session_can_init(int sessiontype, mm_session_admit_reason_t *reason);
+
+/**
+ * This function sets directory where session type information is stored
+ *
+ * @param	path [in] Directory path (default is /tmp, or MM_SESSION_DIR environment variable if set.
+ *		If MM_SESSION_DIR is too long, session records are not accessible until this function is called)
+ *
+ * @return	This function returns MM_ERROR_NONE on success, or negative value
+ *			with error code.
+ * @remark	This function should be called before any other session function.
+ * 			If it is called later, operations in progress finish on either directory
+ * 			and running watch (mm_session_watch) follows new directory
+ * 			when default main context runs next.
+ * 			All processes sharing session policy should use same directory.
+ * @see		_mm_session_util_write_type _mm_session_util_read_type
+ * @since
+ */
+int mm_session_set_state_dir(const char *path);
+
+/**
+ * This function starts connecting to sound server in background
+ *
+ * @return	This function returns MM_ERROR_NONE on success, or negative value
+ *			with error code.
+ * @remark	Call this as early as possible before mm_session_init, then init only has to register session.
+ * 			Setting MM_SESSION_PRECONNECT=1 environment variable starts it when library is loaded.
+ * @see		mm_session_init mm_session_init_ex
+ * @since
+ */
+int mm_session_preconnect(void);
+
+/**
+ * This function sets latency budget of blocking sound server calls
+ *
+ * @param	msec [in] Timeout in milliseconds (0 means wait without limit, default)
+ *
+ * @return	This function returns MM_ERROR_NONE on success, or negative value
+ *			with error code.
+ * @remark	Applies to process status query of mm_session_finish and to mm_session_get_subsession.
+ * 			When time is over, last known value is used if any, otherwise MM_ERROR_SESSION_IPC_TIMEOUT is returned.
+ * 			MM_SESSION_IPC_TIMEOUT_MS environment variable sets it when library is loaded.
+ * @see		mm_session_get_stats
+ * @since
+ */
+int mm_session_set_ipc_timeout(unsigned int msec);
+
+/**
+ * This function sets whether forked child process inherits session type of parent
+ *
+ * @param	enable [in] non-zero to inherit
+ *
+ * @return	This function returns MM_ERROR_NONE on success, or negative value
+ *			with error code.
+ * @remark	Child always starts without ASM handles and callback of parent.
+ * 			If enabled, child keeps session type of parent without sound server call,
+ * 			and its record is written by first session function called in child.
+ * 			Watches of parent (mm_session_watch) are not inherited.
+ * 			Call session types are never inherited.
+ * 			MM_SESSION_FORK_INHERIT=1 environment variable enables it when library is loaded.
+ * @see		mm_session_init_ex
+ * @since
+ */
+int mm_session_set_fork_inherit(int enable);
+
 /**
  * This function delete session type information to system
  *
@@ -97,6 +230,8 @@ int _mm_session_util_write_type(int app_pid, int sessiontype);
  *			with error code.
  * @remark	Session type is unique for each application.
  * 			if application want to change session type, Finish session first and Init again
+ * 			Record of other process written before that process started is left by exited
+ * 			process of same pid, so MM_ERROR_INVALID_HANDLE is returned for it.
  * @see		_mm_session_util_write_type _mm_session_util_delete_type
  * @since
  */
@@ -130,6 +265,84 @@ int mm_session_set_subsession (mm_subsession_t subsession);
  */
 int mm_session_get_subsession (mm_subsession_t *subsession);
 
+/**
+ * This function gets internal counters of session library
+ *
+ * @param	stats [out] counters of caller process
+ *
+ * @return	This function returns MM_ERROR_NONE on success, or negative value
+ *			with error code.
+ * @remark	Lookup counters are only updated when other process's session type is read.
+ * @see		_mm_session_util_read_type
+ * @since
+ */
+int mm_session_get_stats(mm_session_stats_t *stats);
+
+/**
+ * This function gets session information of all processes
+ *
+ * @param	records [out] array of session information, should be released by mm_session_snapshot_free
+ * @param	count [out] number of entries in records
+ *
+ * @return	This function returns MM_ERROR_NONE on success, or negative value
+ *			with error code.
+ * @remark	Session directory is read once, so records are taken in one pass.
+ * @see		mm_session_snapshot_free
+ * @since
+ */
+int mm_session_snapshot(mm_session_record_t **records, int *count);
+
+/**
+ * This function releases session information returned by mm_session_snapshot
+ *
+ * @param	records [in] array returned by mm_session_snapshot
+ *
+ * @see		mm_session_snapshot
+ * @since
+ */
+void mm_session_snapshot_free(mm_session_record_t *records);
+
+/**
+ * This function gets name of session type
+ *
+ * @param	sessiontype	[in] Multimedia Session type
+ *
+ * @return	This function returns constant name such as "SHARE" or "RICH-CALL",
+ *			or NULL if session type is not supported.
+ * @see		mm_session_snapshot
+ * @since
+ */
+const char* mm_session_type_name(int sessiontype);
+
+/**
+ * This function starts watching session type changes of other processes
+ *
+ * @param	app_pid [in] Application pid to watch (MM_SESSION_WATCH_ALL_PID for all processes)
+ * @param	callback [in] watch callback function pointer
+ * @param	user_param [in] callback function user parameter
+ * @param	watch_id [out] identifier to be passed to mm_session_unwatch
+ *
+ * @return	This function returns MM_ERROR_NONE on success, or negative value
+ *			with error code.
+ * @remark	Callback is invoked from the default glib main context, so caller should run main loop.
+ * 			sessiontype is -1 for MM_SESSION_WATCH_DELETED.
+ * @see		mm_session_unwatch
+ * @since
+ */
+int mm_session_watch(int app_pid, session_watch_cb callback, void *user_param, int *watch_id);
+
+/**
+ * This function stops watching session type changes
+ *
+ * @param	watch_id [in] identifier returned by mm_session_watch
+ *
+ * @return	This function returns MM_ERROR_NONE on success, or negative value
+ *			with error code.
+ * @see		mm_session_watch
+ * @since
+ */
+int mm_session_unwatch(int watch_id);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,150 @@
+/*
+ * libmm-session
+ *
+ * Copyright (c) 2000 - 2011 Samsung Electronics Co., Ltd. All rights reserved.
+ *
+ * Contact: Seungbae Shin <seungbae.shin@samsung.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/*
+ * mm-session-stat : prints session information of all processes
+ *
+ * usage : mm-session-stat [-j] [-w interval]
+ *	-j		print JSON
+ *	-w interval	repeat every interval seconds
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+#include <mm_session_private.h>
+#include <mm_error.h>
+
+static const char* _type_name(int sessiontype)
+{
+	const char *name = mm_session_type_name(sessiontype);
+
+	return name ? name : "UNKNOWN";
+}
+
+static const char* _subsession_name(int subsession)
+{
+	switch(subsession)
+	{
+	case MM_SUBSESSION_TYPE_VOICE:		return "VOICE";
+	case MM_SUBSESSION_TYPE_RINGTONE:	return "RINGTONE";
+	case MM_SUBSESSION_TYPE_MEDIA:		return "MEDIA";
+	case -1:							return "-";
+	default:							return "UNKNOWN";
+	}
+}
+
+static long _elapsed_us(const struct timespec *start, const struct timespec *end)
+{
+	return (end->tv_sec - start->tv_sec) * 1000000L + (end->tv_nsec - start->tv_nsec) / 1000L;
+}
+
+static void _print_text(const mm_session_record_t *records, int count, time_t now, long scan_us)
+{
+	int i;
+
+	printf("%-8s %-10s %-10s %8s %s\n", "PID", "TYPE", "SUBSESSION", "AGE(s)", "ALIVE");
+	for(i = 0; i < count; i++) {
+		printf("%-8d %-10s %-10s %8ld %s\n", records[i].pid,
+				_type_name(records[i].sessiontype), _subsession_name(records[i].subsession),
+				(long)(now - records[i].started), records[i].alive ? "yes" : "no");
+	}
+	printf("%d record(s), scanned in %ld us\n", count, scan_us);
+}
+
+static void _print_json(const mm_session_record_t *records, int count, time_t now, long scan_us)
+{
+	int i;
+
+	printf("{\"scan_us\":%ld,\"sessions\":[", scan_us);
+	for(i = 0; i < count; i++) {
+		printf("%s{\"pid\":%d,\"type\":\"%s\",\"subsession\":\"%s\",\"age\":%ld,\"alive\":%s}",
+				i ? "," : "", records[i].pid,
+				_type_name(records[i].sessiontype), _subsession_name(records[i].subsession),
+				(long)(now - records[i].started), records[i].alive ? "true" : "false");
+	}
+	printf("]}\n");
+}
+
+static void _usage(const char *name)
+{
+	fprintf(stderr, "usage : %s [-j] [-w interval]\n", name);
+	fprintf(stderr, "\t-j\t\tprint JSON\n");
+	fprintf(stderr, "\t-w interval\trepeat every interval seconds\n");
+}
+
+int main(int argc, char **argv)
+{
+	mm_session_record_t *records = NULL;
+	struct timespec start, end;
+	int interval = 0;
+	int json = 0;
+	int count = 0;
+	int ret = MM_ERROR_NONE;
+	int opt;
+
+	while((opt = getopt(argc, argv, "jw:h")) != -1) {
+		switch(opt)
+		{
+		case 'j':
+			json = 1;
+			break;
+		case 'w':
+			interval = atoi(optarg);
+			if(interval <= 0) {
+				_usage(argv[0]);
+				return 1;
+			}
+			break;
+		default:
+			_usage(argv[0]);
+			return 1;
+		}
+	}
+
+	do {
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		ret = mm_session_snapshot(&records, &count);
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		if(ret != MM_ERROR_NONE) {
+			fprintf(stderr, "Can not get session snapshot 0x%x\n", ret);
+			return 1;
+		}
+
+		if(json)
+			_print_json(records, count, time(NULL), _elapsed_us(&start, &end));
+		else
+			_print_text(records, count, time(NULL), _elapsed_us(&start, &end));
+		fflush(stdout);
+
+		mm_session_snapshot_free(records);
+		records = NULL;
+
+		if(interval > 0) {
+			if(!json)
+				printf("\n");
+			sleep(interval);
+		}
+	} while(interval > 0);
+
+	return 0;
+}
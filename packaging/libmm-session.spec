@@ -50,9 +50,11 @@ rm -rf %{buildroot}
 %files
 %defattr(-,root,root,-)
 /usr/lib/libmmfsession.so.*
+/usr/bin/mm-session-stat
 
 %files devel
 %defattr(-,root,root,-)
 /usr/include/mmf/*.h
+/usr/include/mmf/*.hpp
 /usr/lib/libmmfsession.so
 /usr/lib/pkgconfig/mm-session.pc